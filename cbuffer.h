@@ -5,29 +5,303 @@
 #include <iostream>
 #include <iterator>
 #include <cstddef>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+/** \brief Struttura base per costruire la lista di cbuffer.
+ * Contiene il dato generico di tipo T e il puntatore al container successivo.
+ */
+template <class T>
+struct cbuffer_container {
+    T value; ///< Dato inserito nella lista
+    /** \brief Puntatore al container successivo
+     * Atomico perché con le letture concorrenti un lettore può seguirlo mentre il writer lo modifica
+     */
+    std::atomic<cbuffer_container *> next;
+    
+    /** costruttore di default che inizializza a NULL */
+    cbuffer_container() : next(0) {}
+    /** \brief Costruttore che permette subito di inizializzare un nodo
+     * con valori già esistenti
+     */
+    cbuffer_container(const T &value, cbuffer_container *next=NULL) : value(value), next(next) {}
+
+    /** \brief Container successivo */
+    cbuffer_container *get_next() const {
+        return next.load(std::memory_order_relaxed);
+    }
+
+    /** \brief Aggiorna il container successivo */
+    void set_next(cbuffer_container *n) {
+        next.store(n, std::memory_order_relaxed);
+    }
+};
+
+/** \brief Gestione dei nodi di cbuffer
+ * cbuffer chiama questi metodi quando crea, rimuove o dealloca nodi e quando
+ * modifica la testa. La specializzazione scelta da concurrent_read decide se i
+ * nodi rimossi vengono deallocati subito o riciclati per le letture concorrenti.
+ * @param T tipo del dato
+ * @param concurrent_read abilita le letture concorrenti
+ */
+template <class T, bool concurrent_read>
+class cbuffer_nodes;
+
+/** \brief Nodi di un cbuffer senza letture concorrenti
+ * Non ha stato: ogni nodo viene allocato all'inserimento e deallocato alla rimozione.
+ */
+template <class T>
+class cbuffer_nodes<T, false> {
+protected:
+    typedef cbuffer_container<T> container;
+
+    /** \brief Alloca il nodo da accodare
+     * @param value valore da copiare nel nodo
+     * @throw eccezione di fallita allocazione dinamica o di copia di T
+     */
+    container *make_node(const T &value, unsigned int) {
+        return new container(value);
+    }
+
+    /** \brief Dealloca il nodo appena rimosso dalla testa */
+    void release_node(container *old) {
+        delete old;
+    }
+
+    void begin_write() {}
+    void node_popped() {}
+    void end_write(container *, unsigned int) {}
+    void publish(container *, unsigned int) {}
+    void nodes_cleared(unsigned int) {}
+    void swap_nodes(cbuffer_nodes &) {}
+};
+
+/** \brief Nodi di un cbuffer con letture concorrenti
+ * Un singolo writer (push_back, pop) può procedere mentre altri thread leggono
+ * con try_visit() e read_snapshot(): i nodi rimossi non vengono deallocati ma
+ * riciclati, e il lettore ripete la lettura solo se il writer ha riusato un nodo
+ * della finestra che stava leggendo (cioè se è stato doppiato).
+ * Il prezzo è fino a 2 * capacity() nodi allocati e valori rimossi che restano
+ * vivi finché il loro nodo non viene riciclato.
+ */
+template <class T>
+class cbuffer_nodes<T, true> {
+protected:
+    typedef cbuffer_container<T> container;
+
+private:
+    /** \brief Primo dei nodi rimossi, in attesa di essere riciclati
+     * I nodi rimossi restano collegati tra loro tramite next nell'ordine di rimozione
+     */
+    container *_free_head;
+    /** \brief Ultimo dei nodi rimossi */
+    container *_free_tail;
+    /** \brief Numero di nodi rimossi in attesa di essere riciclati */
+    unsigned int _free_size;
+    /** \brief Indice logico dell'elemento in testa (numero di elementi rimossi finora) */
+    unsigned long long _first;
+    /** \brief Contatore di versione della testa: dispari durante una modifica */
+    std::atomic<unsigned long> _seq;
+    /** \brief Testa, dimensione e indice logico della testa pubblicati ai lettori */
+    std::atomic<container *> _snap_head;
+    std::atomic<unsigned int> _snap_size;
+    std::atomic<unsigned long long> _snap_first;
+    /** \brief Gli elementi con indice logico minore di _lapped possono essere stati sovrascritti */
+    std::atomic<unsigned long long> _lapped;
+
+    /** \brief Dealloca i nodi in attesa di essere riciclati */
+    void release_free() {
+        container *temp;
+        for (unsigned int i = 0; i < _free_size; i++) {
+            temp = _free_head;
+            _free_head = _free_head->get_next();
+            delete temp;
+        }
+        _free_head = NULL;
+        _free_tail = NULL;
+        _free_size = 0;
+    }
+
+    /** \brief Funtore usato da read_snapshot() per copiare gli elementi in un array */
+    struct snapshot_writer {
+        T *dest;
+        unsigned int *count;
+
+        snapshot_writer(T *d, unsigned int *c) : dest(d), count(c) {}
+
+        void operator()(const T &value) {
+            dest[(*count)++] = value;
+        }
+    };
+
+protected:
+    cbuffer_nodes() : _free_head(NULL), _free_tail(NULL), _free_size(0), _first(0), _seq(0),
+        _snap_head(NULL), _snap_size(0), _snap_first(0), _lapped(0) {}
+
+    ~cbuffer_nodes() {
+        release_free();
+    }
+
+    /** \brief Crea il nodo da accodare
+     * Ricicla il nodo rimosso da più tempo se ne sono in attesa almeno max_size,
+     * altrimenti ne alloca uno nuovo. Tenere max_size nodi di riserva garantisce
+     * che un lettore venga interrotto solo se il writer lo ha doppiato.
+     * @param value valore da copiare nel nodo
+     * @param max_size capacità del buffer
+     * @throw eccezione di fallita allocazione dinamica o di copia di T
+     */
+    container *make_node(const T &value, unsigned int max_size) {
+        if (_free_size == 0 || _free_size < max_size)
+            return new container(value);
+
+        container *temp = _free_head;
+        _free_size--;
+        _free_head = _free_size > 0 ? temp->get_next() : NULL;
+        if (_free_head == NULL)
+            _free_tail = NULL;
+        // I nodi in attesa hanno indici logici [_first - _free_size, _first):
+        // da qui in poi quello appena preso non è più leggibile
+        _lapped.store(_first - _free_size, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        try {
+            temp->value = value;
+        } catch (...) {
+            // Un lettore doppiato potrebbe essere ancora sul nodo: lo rimetto in attesa
+            _free_head = temp;
+            if (_free_tail == NULL)
+                _free_tail = temp;
+            _free_size++;
+            throw;
+        }
+        temp->set_next(NULL);
+        return temp;
+    }
+
+    /** \brief Mette in attesa di riciclo il nodo appena rimosso dalla testa
+     * Il nodo non viene deallocato, così un lettore concorrente non accede mai a memoria liberata.
+     */
+    void release_node(container *old) {
+        // old->next punta già al nodo successivo: lo collego ai nodi in attesa
+        // solo se il buffer era stato svuotato nel frattempo
+        if (_free_tail == NULL)
+            _free_head = old;
+        else if (_free_tail->get_next() != old)
+            _free_tail->set_next(old);
+        _free_tail = old;
+        _free_size++;
+    }
+
+    /** \brief Inizio di una modifica della testa o della dimensione */
+    void begin_write() {
+        _seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    /** \brief La testa è stata rimossa (tra begin_write() ed end_write()) */
+    void node_popped() {
+        _first++;
+    }
+
+    /** \brief Pubblica testa e dimensione ai lettori */
+    void publish(container *head, unsigned int size) {
+        _snap_head.store(head, std::memory_order_relaxed);
+        _snap_size.store(size, std::memory_order_relaxed);
+        _snap_first.store(_first, std::memory_order_relaxed);
+    }
+
+    /** \brief Fine di una modifica iniziata con begin_write(): pubblica la nuova testa */
+    void end_write(container *head, unsigned int size) {
+        publish(head, size);
+        _seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /** \brief Il buffer è stato svuotato deallocando size elementi */
+    void nodes_cleared(unsigned int size) {
+        _first += size;
+        release_free();
+    }
+
+    /** \brief Scambia i nodi in attesa con quelli di other (usato dall'assegnamento) */
+    void swap_nodes(cbuffer_nodes &other) {
+        std::swap(other._free_head, _free_head);
+        std::swap(other._free_tail, _free_tail);
+        std::swap(other._free_size, _free_size);
+        std::swap(other._first, _first);
+        _lapped.store(other._lapped.exchange(_lapped.load()));
+    }
+
+public:
+    /** \brief Legge la finestra corrente senza bloccare il writer
+     * Chiama visitor su ogni elemento, dal più vecchio al più recente, senza copiare il buffer.
+     * Può essere usato da un thread diverso da quello che chiama push_back() e pop().
+     * Se il writer ha riusato un nodo della finestra durante la lettura, visitor
+     * può aver visto valori non validi: il risultato va scartato e la lettura ripetuta.
+     * Richiede T banalmente copiabile, perché un valore letto mentre il writer lo
+     * sovrascrive non deve mai portare a seguire memoria liberata.
+     * @param visitor funtore unario chiamato con const T&
+     * @return true se la lettura è consistente, false se il lettore è stato doppiato
+     */
+    template <class F>
+    bool try_visit(F visitor) const {
+        static_assert(std::is_trivially_copyable<T>::value,
+            "try_visit richiede un tipo T banalmente copiabile");
+        const container *current;
+        unsigned int n;
+        unsigned long long first;
+        unsigned long seq;
+        // Lettura consistente di testa, dimensione e indice logico
+        do {
+            seq = _seq.load(std::memory_order_acquire);
+            current = _snap_head.load(std::memory_order_relaxed);
+            n = _snap_size.load(std::memory_order_relaxed);
+            first = _snap_first.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || _seq.load(std::memory_order_relaxed) != seq);
+
+        for (unsigned int i = 0; i < n; i++) {
+            // Un nodo riciclato ha next a NULL: sono stato doppiato
+            if (current == NULL)
+                return false;
+            visitor(current->value);
+            if (i + 1 < n)
+                current = current->get_next();
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return _lapped.load(std::memory_order_relaxed) <= first;
+    }
+
+    /** \brief Copia la finestra corrente in dest senza bloccare il writer
+     * Ripete la lettura finché non è consistente (vedi try_visit()).
+     * @param dest array di almeno capacity() elementi
+     * @return numero di elementi copiati
+     */
+    unsigned int read_snapshot(T *dest) const {
+        static_assert(std::is_trivially_copyable<T>::value,
+            "read_snapshot richiede un tipo T banalmente copiabile");
+        unsigned int n;
+        do {
+            n = 0;
+        } while (!try_visit(snapshot_writer(dest, &n)));
+        return n;
+    }
+};
 
 /** \brief Buffer circolare
  * Implementa un buffer circolare di dimensione massima fissata contenente elementi di 
  * tipo generico.
  * Al riempimento del buffer, quando si inserisce un nuovo elemento, viene sovrascritto il più vecchio
+ *
+ * Con concurrent_read a true il buffer offre try_visit() e read_snapshot() per
+ * leggere da altri thread mentre un singolo writer inserisce e rimuove
+ * (vedi cbuffer_nodes<T, true>). Con false (default) pop() dealloca subito.
  * @param T tipo del dato
+ * @param concurrent_read abilita le letture concorrenti
  */
-template <class T>
-class cbuffer {
-    /** \brief Struttura base per costruire la lista.
-     * Contiene il dato generico di tipo T e il puntatore al container successivo.
-     */
-    struct container {
-        T value; ///< Dato inserito nella lista
-        container *next; ///> Puntatore al container successivo
-        
-        /** costruttore di default che inizializza a NULL */
-        container() : next(0) {}
-        /** \brief Costruttore che permette subito di inizializzare un nodo
-         * con valori già esistenti
-         */
-        container(const T &value, container *next=NULL) : value(value), next(next) {}
-    };
+template <class T, bool concurrent_read = false>
+class cbuffer : public cbuffer_nodes<T, concurrent_read> {
+    typedef cbuffer_nodes<T, concurrent_read> nodes;
+    typedef typename nodes::container container;
 
     /** \brief Puntatore alla testa del buffer */
     container *_head;
@@ -38,23 +312,66 @@ class cbuffer {
     /** \brief Massimo numero di elementi contemporaneamente presenti nel buffer */
     unsigned int _max_size;
 
+    /** \brief Hash polinomiale della finestra: somma di hash(v_i) * HASH_BASE^(_size - 1 - i) */
+    unsigned long long _hash;
+    /** \brief HASH_BASE^_size, peso che avrà il prossimo elemento rimosso dopo un inserimento */
+    unsigned long long _hash_pow;
+    /** \brief false se un elemento può essere stato modificato tramite iterator o operator[] */
+    bool _hash_valid;
+
+    /** \brief Base dell'hash polinomiale (dispari, quindi invertibile modulo 2^64) */
+    static const unsigned long long HASH_BASE = 0x100000001b3ULL;
+    /** \brief Inverso di HASH_BASE modulo 2^64 */
+    static const unsigned long long HASH_BASE_INV = 0xce965057aff6957bULL;
+
+    /** \brief Hash di un elemento, coerente con operator== di T
+     * Usa std::hash<T> se esiste, altrimenti 0 (l'hash della finestra dipende
+     * allora solo dalla dimensione).
+     */
+    static unsigned long long element_hash(const T &value) {
+        return element_hash(value, 0);
+    }
+
+    template <class U>
+    static auto element_hash(const U &value, int)
+            -> decltype(static_cast<unsigned long long>(std::hash<U>()(value))) {
+        return std::hash<U>()(value);
+    }
+
+    static unsigned long long element_hash(const T &, long) {
+        return 0;
+    }
+
+    /** \brief Hash della finestra calcolato da zero scorrendo la lista */
+    unsigned long long compute_hash() const {
+        unsigned long long h = 0;
+        const container *current = _head;
+        for (unsigned int i = 0; i < _size; i++) {
+            h = h * HASH_BASE + element_hash(current->value);
+            current = current->get_next();
+        }
+        return h;
+    }
+
 public:
     /** \brief Costruttore di default
      * Inizializza un buffer con dimensione massima a 10
      */
-    cbuffer(unsigned int max=10) : _head(NULL), _tail(NULL), _size(0), _max_size(max) {}
+    cbuffer(unsigned int max=10) : nodes(), _head(NULL), _tail(NULL), _size(0), _max_size(max),
+        _hash(0), _hash_pow(1), _hash_valid(true) {}
 
     /** \brief Costruttore copia
      * 
      * @param other lista da copiare
      * @throw eccezione di fallita allocazione dinamica
      */
-    cbuffer(const cbuffer &other) : _head(NULL), _tail(NULL), _size(0), _max_size(other._max_size) {
+    cbuffer(const cbuffer &other) : nodes(), _head(NULL), _tail(NULL), _size(0), _max_size(other._max_size),
+        _hash(0), _hash_pow(1), _hash_valid(true) {
         const container *current = other._head;
         try {
             for (unsigned int i = 0; i < other._size; i++) {
                 push_back(current->value);
-                current = current->next;
+                current = current->get_next();
             }
         } catch (...) {
             clear();
@@ -70,10 +387,13 @@ public:
      * @throw eccezione di fallita allocazione dinamica
      */
     template <class IT>
-    cbuffer(unsigned int max, IT begin, IT end) : _max_size(max) {
+    cbuffer(unsigned int max, IT begin, IT end) : nodes(), _max_size(max) {
         _head = NULL;
         _tail = NULL;
         _size = 0;
+        _hash = 0;
+        _hash_pow = 1;
+        _hash_valid = true;
         try {
             for(; begin != end; begin++) {
                 push_back(static_cast<T>(*begin));
@@ -85,17 +405,25 @@ public:
     }
 
     /** \brief Rimuove un elemento dalla testa del buffer 
-     * Se la lista non è vuota elimina l'elemento in testa deallocandolo
+     * Se la lista non è vuota elimina l'elemento in testa deallocandolo.
+     * Con concurrent_read il nodo viene invece messo in attesa di essere riciclato.
      */
     void pop() {
         if (_head != NULL) {
             container *old = _head;
-            _head = _head->next;
+            this->begin_write();
+            _head = _head->get_next();
             _size--;
-            delete old;
+            this->node_popped();
             // Se ho eliminato l'unico elemento allora setto anche la coda a NULL
             if (_head == NULL)
                 _tail = NULL;
+            this->end_write(_head, _size);
+
+            // L'elemento rimosso aveva peso HASH_BASE^_size (già decrementata)
+            _hash_pow *= HASH_BASE_INV;
+            _hash -= element_hash(old->value) * _hash_pow;
+            this->release_node(old);
         }
     }
 
@@ -114,31 +442,41 @@ public:
             return;
         }
 
-        container *temp = new container(value);
+        container *temp = this->make_node(value, _max_size);
+        _hash = _hash * HASH_BASE + element_hash(value);
+        _hash_pow *= HASH_BASE;
+        this->begin_write();
         if (_head == NULL) {
             _head = temp;
             _size++;
             _tail = temp;
+            this->end_write(_head, _size);
             return;
         }
         // Collego l'ultimo nodo e aggiorno la coda
-        _tail->next = temp;
+        _tail->set_next(temp);
         _tail = temp;
         _size++;
+        this->end_write(_head, _size);
     }
 
     /** \brief Dealloca il buffer
-     * Svuota completamente la lista deallocando ogni elemento
+     * Svuota completamente la lista deallocando ogni elemento, compresi i nodi
+     * in attesa di essere riciclati. Non può essere chiamato durante una lettura concorrente.
      */
     void clear() {
         container *temp;
         for (unsigned int i = 0; i < _size; i++) {
             temp = _head;
-            _head = _head->next;
+            _head = _head->get_next();
             delete temp;
         }
+        this->nodes_cleared(_size);
         _size = 0;
         _tail = NULL;
+        _hash = 0;
+        _hash_pow = 1;
+        _hash_valid = true;
     }
 
     /** \brief Ritorna l'elemento in testa al buffer */
@@ -165,12 +503,32 @@ public:
         return _max_size;
     }
 
+    /** \brief Operatore per accedere all'i-esimo elemento (sola lettura)
+     * Non è lineare, ma impiega O(n)
+     * @param i posizione dell'elemento
+     * @throw eccezione posizione non accessibile
+     */
+    const T& operator[](unsigned int i) const {
+        return node_at(i)->value;
+    }
+
     /** \brief Operatore per accedere all'i-esimo elemento
      * Non è lineare, ma impiega O(n)
+     * Il riferimento ritornato permette di modificare l'elemento: l'hash mantenuto
+     * incrementalmente non è più affidabile fino alla prossima rehash()
      * @param i posizione dell'elemento
      * @throw eccezione posizione non accessibile
      */
-    T& operator[](unsigned int i) const {
+    T& operator[](unsigned int i) {
+        _hash_valid = false;
+        return node_at(i)->value;
+    }
+
+private:
+    /** \brief Nodo in posizione i
+     * @throw eccezione posizione non accessibile
+     */
+    container *node_at(unsigned int i) const {
         try {
             if (i >= _size) {
                 throw;
@@ -182,11 +540,13 @@ public:
         
         container *current = _head;
         for (unsigned int j = 0; j < i; j++) {
-            current = current->next;
+            current = current->get_next();
         }
-        return current->value;
+        return current;
     }
 
+public:
+
     /** \brief Operatore di assegnamento
      * @param other cbuffer da copiare
      * @return reference a this
@@ -198,6 +558,11 @@ public:
             std::swap(temp._tail, _tail);
             std::swap(temp._size, _size);
             std::swap(temp._max_size, _max_size);
+            this->swap_nodes(temp);
+            std::swap(temp._hash, _hash);
+            std::swap(temp._hash_pow, _hash_pow);
+            std::swap(temp._hash_valid, _hash_valid);
+            this->publish(_head, _size);
         }
         return *this;
     }
@@ -206,20 +571,24 @@ public:
      * Due cbuffer sono uguali se hanno la stessa dimensione fissa
      * lo stesso numero di elementi allocati e per ogni elemento
      * lo stesso valore
+     * Se entrambi gli hash sono affidabili e diversi i buffer sono diversi
+     * senza scorrere gli elementi (O(1)), altrimenti il confronto è O(n)
      * @param other lista da confrontare
      */
     bool equals(const cbuffer &other) const {
         if (other._size != _size || other._max_size != _max_size)
             return false;
-        const container *current = _head;
-        const container *c_other = other._head;
-        for (unsigned int i = 0; i < _size; i++) {
-            if (current->value != c_other->value)
-                return false;
-            current = current->next;
-            c_other = c_other->next;
-        }
-        return true;
+        if (_hash_valid && other._hash_valid && _hash != other._hash)
+            return false;
+        return mismatch(other) == _size;
+    }
+
+    /** \brief operatore di uguaglianza 
+     * Richiama equals()
+     * @param other lista da confrontare
+     */
+    bool operator==(const cbuffer &other) const {
+        return equals(other);
     }
 
     /** \brief operatore di disuguaglianza 
@@ -227,7 +596,45 @@ public:
      * @param other lista da confrontare
      */
     bool operator!=(const cbuffer &other) const {
-        return !(this == &other);
+        return !(*this == other);
+    }
+
+    /** \brief Prima posizione in cui i due buffer differiscono
+     * Gli elementi vengono confrontati con operator!= di T
+     * @param other lista da confrontare
+     * @return indice logico del primo elemento diverso; se un buffer è un prefisso
+     * dell'altro la dimensione del più corto, se sono uguali size()
+     */
+    unsigned int mismatch(const cbuffer &other) const {
+        unsigned int n = _size < other._size ? _size : other._size;
+        const container *current = _head;
+        const container *c_other = other._head;
+        for (unsigned int i = 0; i < n; i++) {
+            if (current != c_other && current->value != c_other->value)
+                return i;
+            current = current->get_next();
+            c_other = c_other->get_next();
+        }
+        return n;
+    }
+
+    /** \brief Hash del contenuto del buffer
+     * Mantenuto in O(1) da push_back() e pop(), anche quando un inserimento
+     * sovrascrive l'elemento più vecchio. Buffer con gli stessi elementi hanno lo
+     * stesso hash. Se un elemento può essere stato modificato tramite iterator o
+     * operator[] viene ricalcolato in O(n).
+     */
+    unsigned long long hash() const {
+        return _hash_valid ? _hash : compute_hash();
+    }
+
+    /** \brief Ricalcola l'hash mantenuto incrementalmente
+     * Da chiamare dopo aver modificato elementi tramite iterator o operator[],
+     * quando non si conservano più riferimenti agli elementi, per tornare al confronto rapido.
+     */
+    void rehash() {
+        _hash = compute_hash();
+        _hash_valid = true;
     }
 
     /** \brief Distruttore che richiama clear() */
@@ -319,7 +726,7 @@ public:
              * Passa al container successivo, ritornando sè stesso
              */
             iterator& operator++() {
-                current = current->next;
+                current = current->get_next();
                 return *this;
             }
 
@@ -328,7 +735,7 @@ public:
              */
             iterator operator++(int) {
                 iterator it(*this);
-                current = current->next;
+                current = current->get_next();
                 return it;
             }
 
@@ -339,7 +746,7 @@ public:
             iterator operator+(unsigned int offset) {
                 unsigned int i = 0;
                 while (current != NULL && i < offset) {
-                    current = current->next;
+                    current = current->get_next();
                     i++;
                 }
                 // Tiro un'eccezione se sto accedendo a una cella non valida
@@ -425,7 +832,7 @@ public:
              * Passa al container successivo, ritornando sè stesso
              */
             const_iterator& operator++() {
-                current = current->next;
+                current = current->get_next();
                 return (*this);
             }
 
@@ -442,7 +849,7 @@ public:
              */
             const_iterator operator++(int) {
                 const_iterator it(*this);
-                current = current->next;
+                current = current->get_next();
                 return it;
             }
 
@@ -453,7 +860,7 @@ public:
             const_iterator operator+(unsigned int offset) {
                 unsigned int i = 0;
                 while (current != NULL && i < offset) {
-                    current = current->next;
+                    current = current->get_next();
                     i++;
                 }
                 // Tiro un'eccezione se sto accedendo a una cella non valida
@@ -469,8 +876,11 @@ public:
             }
     };
 
-    /** \brief Iteratore dell'elemento in testa al buffer */
+    /** \brief Iteratore dell'elemento in testa al buffer
+     * Permette di modificare gli elementi: l'hash non è più affidabile fino alla prossima rehash()
+     */
     iterator begin() {
+        _hash_valid = false;
         return iterator(_head);
     }
 
@@ -493,10 +903,10 @@ public:
 /** \brief Operatore di output 
  * Operando con gli iteratori scorre il buffer e ne visualizza i dati
  */
-template <class T>
-std::ostream &operator<<(std::ostream &os, const cbuffer<T> &cb) {
+template <class T, bool concurrent_read>
+std::ostream &operator<<(std::ostream &os, const cbuffer<T, concurrent_read> &cb) {
 	
-	typename cbuffer<T>::const_iterator i, ie;
+	typename cbuffer<T, concurrent_read>::const_iterator i, ie;
 
 	for(i = cb.begin(), ie = cb.end(); i!=ie; i++)
 		os << *i << std::endl;
@@ -509,10 +919,10 @@ std::ostream &operator<<(std::ostream &os, const cbuffer<T> &cb) {
  * @param unary_funct funtore unario
  * Stampa a video il risultato di unary_funct per ogni elemento di cb 
  */
-template <class T, class F>
-void evaluate_if(const cbuffer<T> &cb, F unary_funct) {
-    typename cbuffer<T>::const_iterator it = cb.begin();
-    typename cbuffer<T>::const_iterator it_e = cb.end();
+template <class T, bool concurrent_read, class F>
+void evaluate_if(const cbuffer<T, concurrent_read> &cb, F unary_funct) {
+    typename cbuffer<T, concurrent_read>::const_iterator it = cb.begin();
+    typename cbuffer<T, concurrent_read>::const_iterator it_e = cb.end();
     for(int i = 0; it != it_e; it++, i++) {
         std::cout << i << ": " << (unary_funct(*it) ? "true" : "false") << std::endl;
     }
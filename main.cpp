@@ -29,6 +29,12 @@ std::ostream &operator<<(std::ostream &os, const rectangle &r) {
 	return os;
 }
 
+/** \brief Tipo copiabile ma non assegnabile (membro const) */
+struct fixed_point {
+    const int x;
+    fixed_point(int xx) : x(xx) {}
+};
+
 int test_array[3] = {1, 0, 3};
 cbuffer<int> test_cb(3, test_array, test_array+3);
 const cbuffer<int> const_test_cb(3, test_array, test_array+3);
@@ -76,6 +82,15 @@ void test_push_more_n() {
     std::cout << cb;
 }
 
+void test_push_non_assignable() {
+    std::cout << "Test inserimento tipo non assegnabile > max_size: ";
+    cbuffer<fixed_point> cb(2);
+    for (int i = 0; i < 5; i++)
+        cb.push_back(fixed_point(i));
+    bool passed = cb.size() == 2 && cb[0].x == 3 && cb[1].x == 4;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
 void test_operator_equal() {
     std::cout << "Test operatore = : ";
     cbuffer<int> cb(3);
@@ -170,9 +185,75 @@ void test_evaluate_if() {
     evaluate_if(test_rect_cb, is_square());
 }
 
+void test_equality_hash() {
+    std::cout << "Test operatori ==, != e hash: ";
+    int array[4] = {5, 6, 7, 8};
+    cbuffer<int> cb(4, array, array+4);
+    // Stessi elementi dopo aver sovrascritto il buffer più volte
+    cbuffer<int> cb_wrapped(4);
+    for (int i = 0; i < 9; i++)
+        cb_wrapped.push_back(i);
+    bool passed =
+        cb == cb_wrapped &&
+        !(cb != cb_wrapped) &&
+        cb.hash() == cb_wrapped.hash() &&
+        cb.mismatch(cb_wrapped) == 4;
+    cb_wrapped.push_back(9);
+    passed = passed &&
+        cb != cb_wrapped &&
+        cb.hash() != cb_wrapped.hash() &&
+        cb.mismatch(cb_wrapped) == 0;
+    // Modifica tramite operator[]: l'hash viene ricalcolato
+    cbuffer<int> cb_copy(cb_wrapped);
+    cb_wrapped[3] = 10;
+    passed = passed &&
+        cb_wrapped.mismatch(cb_copy) == 3 &&
+        cb_wrapped != cb_copy &&
+        cb_wrapped.hash() != cb_copy.hash();
+    cb_wrapped[3] = 9;
+    passed = passed && cb_wrapped == cb_copy;
+    cb_wrapped.rehash();
+    passed = passed && cb_wrapped.hash() == cb_copy.hash();
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+/** \brief Funtore che durante la lettura inserisce `n` elementi nel buffer
+ * Simula un writer concorrente che doppia il lettore
+ */
+struct lapping_writer {
+    cbuffer<int, true> *cb;
+    unsigned int n;
+    lapping_writer(cbuffer<int, true> *c, unsigned int nn) : cb(c), n(nn) {}
+    void operator()(const int &) {
+        for (; n > 0; n--)
+            cb->push_back(-1);
+    }
+};
+
+void test_snapshot() {
+    std::cout << "Test lettura snapshot: ";
+    cbuffer<int, true> cb(4);
+    for (int i = 0; i < 11; i++)
+        cb.push_back(i);
+    int snapshot[4];
+    unsigned int n = cb.read_snapshot(snapshot);
+    bool passed =
+        n == 4 &&
+        snapshot[0] == 7 &&
+        snapshot[3] == 10 &&
+        cb.try_visit(is_zero<int>());
+    // Finché restano nodi di riserva la lettura resta valida, poi il lettore è doppiato
+    passed = passed && cb.try_visit(lapping_writer(&cb, 3));
+    passed = passed && !cb.try_visit(lapping_writer(&cb, 8));
+    n = cb.read_snapshot(snapshot);
+    passed = passed && n == 4 && snapshot[0] == -1;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
 int main() {
     test_push_less_n();
     test_push_more_n();
+    test_push_non_assignable();
     test_direct_access();
     test_modify_element();
     test_creazione_cb_da_cb();
@@ -182,5 +263,7 @@ int main() {
     test_pop();
     test_push_rectangle();
     test_evaluate_if();
+    test_snapshot();
+    test_equality_hash();
     return 0;
 }
\ No newline at end of file
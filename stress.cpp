@@ -0,0 +1,645 @@
+#include "cbuffer.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <memory>
+
+/** \brief Istogramma delle latenze in stile HDR
+ * I valori (in nanosecondi) vengono raggruppati per potenza di 2 e ogni potenza
+ * è divisa in SUB_BUCKETS/2 intervalli lineari: l'errore relativo sui percentili
+ * resta sotto 2/SUB_BUCKETS indipendentemente dall'ordine di grandezza.
+ */
+class latency_histogram {
+    static const unsigned int SUB_BITS = 7;
+    static const unsigned int SUB_BUCKETS = 1u << SUB_BITS;
+    static const unsigned int MAGNITUDES = 64 - SUB_BITS + 1;
+
+    /** \brief Contatori, uno per ogni intervallo */
+    std::vector<unsigned long long> _counts;
+    /** \brief Numero totale di campioni */
+    unsigned long long _total;
+    /** \brief Valore massimo registrato */
+    unsigned long long _max;
+
+    /** \brief Indice dell'intervallo che contiene value */
+    static unsigned int index_of(unsigned long long value) {
+        if (value < SUB_BUCKETS)
+            return static_cast<unsigned int>(value);
+        unsigned int magnitude = 63 - __builtin_clzll(value) - SUB_BITS + 1;
+        unsigned int sub = static_cast<unsigned int>(value >> magnitude) & (SUB_BUCKETS - 1);
+        return magnitude * SUB_BUCKETS + sub;
+    }
+
+    /** \brief Estremo superiore (incluso) dei valori dell'intervallo index */
+    static unsigned long long upper_bound_of(unsigned int index) {
+        unsigned int magnitude = index / SUB_BUCKETS;
+        unsigned long long sub = index % SUB_BUCKETS;
+        return ((sub + 1) << magnitude) - 1;
+    }
+
+public:
+    latency_histogram() : _counts(MAGNITUDES * SUB_BUCKETS, 0), _total(0), _max(0) {}
+
+    /** \brief Registra un campione
+     * @param value latenza in nanosecondi
+     */
+    void record(unsigned long long value) {
+        _counts[index_of(value)]++;
+        _total++;
+        if (value > _max)
+            _max = value;
+    }
+
+    /** \brief Somma i campioni di un altro istogramma */
+    void merge(const latency_histogram &other) {
+        for (unsigned int i = 0; i < _counts.size(); i++)
+            _counts[i] += other._counts[i];
+        _total += other._total;
+        if (other._max > _max)
+            _max = other._max;
+    }
+
+    /** \brief Valore sotto il quale cade la percentuale p dei campioni
+     * @param p percentile richiesto, tra 0 e 100
+     */
+    unsigned long long percentile(double p) const {
+        if (_total == 0)
+            return 0;
+        unsigned long long rank = static_cast<unsigned long long>(std::ceil(p / 100.0 * _total));
+        if (rank < 1)
+            rank = 1;
+        if (rank > _total)
+            rank = _total;
+        unsigned long long seen = 0;
+        for (unsigned int i = 0; i < _counts.size(); i++) {
+            seen += _counts[i];
+            if (seen >= rank)
+                return upper_bound_of(i) < _max ? upper_bound_of(i) : _max;
+        }
+        return _max;
+    }
+
+    unsigned long long count() const {
+        return _total;
+    }
+
+    unsigned long long max() const {
+        return _max;
+    }
+};
+
+/** \brief Insieme dei seq già osservati per un produttore
+ * Bitmap suddivisa in blocchi allocati alla prima osservazione, aggiornabile
+ * da più thread: serve a verificare che ogni (produttore, seq) sia osservato
+ * esattamente una volta tra consumati, sovrascritti e rimasti nel buffer.
+ */
+class seen_set {
+    static const unsigned int CHUNK_SHIFT = 20;
+    static const unsigned long long CHUNK_BITS = 1ull << CHUNK_SHIFT;
+    static const unsigned int CHUNK_WORDS = CHUNK_BITS / 64;
+    static const unsigned int MAX_CHUNKS = 1u << 16;
+
+    typedef std::atomic<unsigned long long> word;
+
+    /** \brief Blocchi della bitmap, NULL finché non vengono usati */
+    std::unique_ptr<std::atomic<word *>[]> _chunks;
+
+    word *chunk(unsigned long long index) {
+        word *c = _chunks[index].load(std::memory_order_acquire);
+        if (c != NULL)
+            return c;
+        word *fresh = new word[CHUNK_WORDS]();
+        if (_chunks[index].compare_exchange_strong(c, fresh, std::memory_order_acq_rel))
+            return fresh;
+        delete[] fresh;
+        return c;
+    }
+
+public:
+    seen_set() : _chunks(new std::atomic<word *>[MAX_CHUNKS]()) {}
+
+    ~seen_set() {
+        if (!_chunks)
+            return;
+        for (unsigned int i = 0; i < MAX_CHUNKS; i++)
+            delete[] _chunks[i].load();
+    }
+
+    /** \brief Segna seq come osservato
+     * @return false se seq era già stato osservato o è fuori dall'intervallo gestito
+     */
+    bool mark(unsigned long long seq) {
+        if ((seq >> CHUNK_SHIFT) >= MAX_CHUNKS)
+            return false;
+        word *c = chunk(seq >> CHUNK_SHIFT);
+        unsigned long long bit = 1ull << (seq % 64);
+        return (c[(seq % CHUNK_BITS) / 64].fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+    }
+
+    /** \brief Numero di seq in [0, n) mai osservati (da chiamare a thread fermi) */
+    unsigned long long missing(unsigned long long n) const {
+        unsigned long long count = 0;
+        for (unsigned long long seq = 0; seq < n; seq++) {
+            word *c = (seq >> CHUNK_SHIFT) < MAX_CHUNKS ?
+                _chunks[seq >> CHUNK_SHIFT].load() : NULL;
+            if (c == NULL || (c[(seq % CHUNK_BITS) / 64].load() & (1ull << (seq % 64))) == 0)
+                count++;
+        }
+        return count;
+    }
+};
+
+/** \brief Parametri della prova */
+struct stress_config {
+    unsigned int producers;
+    unsigned int consumers;
+    unsigned int readers;
+    std::string read_mode;
+    unsigned int capacity;
+    unsigned int elem_size;
+    double duration;
+    double rate; ///< inserimenti al secondo per produttore, 0 = senza limite
+    std::string format;
+    std::string out;
+
+    stress_config() : producers(2), consumers(2), readers(0), read_mode("snapshot"), capacity(1024), elem_size(64),
+        duration(5.0), rate(0), format("csv"), out("") {}
+};
+
+/** \brief Elemento inserito nel buffer durante la prova
+ * Contiene l'identità del produttore, un numero di sequenza crescente per
+ * produttore e un riempitivo che porta l'elemento a circa N byte.
+ * Il riempitivo è derivato da seq per poter rilevare elementi corrotti.
+ */
+template <unsigned int N>
+struct payload {
+    unsigned int producer;
+    unsigned long long seq;
+    unsigned char pad[N > 16 ? N - 16 : 1];
+
+    payload() : producer(0), seq(0) {
+        std::memset(pad, 0, sizeof(pad));
+    }
+
+    payload(unsigned int p, unsigned long long s) : producer(p), seq(s) {
+        std::memset(pad, static_cast<unsigned char>(s), sizeof(pad));
+    }
+
+    /** \brief Verifica che il riempitivo sia coerente con seq */
+    bool intact() const {
+        unsigned char expected = static_cast<unsigned char>(seq);
+        return pad[0] == expected && pad[sizeof(pad) - 1] == expected;
+    }
+};
+
+/** \brief Risultati di una prova */
+struct stress_result {
+    latency_histogram push_latency;
+    latency_histogram pop_latency;
+    latency_histogram read_latency;
+    unsigned long long produced;
+    unsigned long long consumed;
+    unsigned long long overwritten;
+    unsigned long long remaining;
+    unsigned long long empty_polls;
+    unsigned long long duplicates;
+    unsigned long long lost;
+    unsigned long long order_violations;
+    unsigned long long corrupted;
+    unsigned long long read_retries;
+    unsigned long long torn_reads;
+
+    stress_result() : produced(0), consumed(0), overwritten(0), remaining(0),
+        empty_polls(0), duplicates(0), lost(0), order_violations(0), corrupted(0), read_retries(0), torn_reads(0) {}
+
+    /** \brief Nessun elemento perso o duplicato: ogni (produttore, seq) prodotto è
+     * stato osservato esattamente una volta tra consumati, sovrascritti e rimasti
+     */
+    bool no_loss() const {
+        return produced == consumed + overwritten + remaining && duplicates == 0 && lost == 0;
+    }
+
+    bool passed() const {
+        return no_loss() && order_violations == 0 && corrupted == 0 && torn_reads == 0;
+    }
+};
+
+/** \brief cbuffer protetto da un mutex
+ * cbuffer non è thread-safe: ogni scrittura della prova passa da qui.
+ * Con concurrent_read i lettori possono leggere con try_visit() senza il mutex.
+ */
+typedef std::chrono::steady_clock stress_clock;
+
+static unsigned long long elapsed_ns(stress_clock::time_point from, stress_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+template <class T, bool concurrent_read>
+struct locked_cbuffer {
+    cbuffer<T, concurrent_read> cb;
+    std::mutex lock;
+
+    locked_cbuffer(unsigned int capacity) : cb(capacity) {}
+
+    /** \brief Inserisce value
+     * @param dropped se il buffer era pieno, riceve l'elemento in testa sovrascritto
+     * @param end istante subito dopo push_back(), prima della copia in dropped
+     * @return true se l'inserimento ha sovrascritto l'elemento più vecchio
+     */
+    bool push(const T &value, T &dropped, stress_clock::time_point &end) {
+        std::lock_guard<std::mutex> guard(lock);
+        bool full = cb.size() == cb.capacity();
+        if (!full) {
+            cb.push_back(value);
+            end = stress_clock::now();
+            return false;
+        }
+        // La testa va salvata prima che push_back() la sovrascriva: la copia
+        // resta sotto il mutex ma fuori dalla latenza misurata
+        const cbuffer<T, concurrent_read> &view = cb;
+        stress_clock::time_point copy_start = stress_clock::now();
+        dropped = *view.begin();
+        stress_clock::time_point copy_end = stress_clock::now();
+        cb.push_back(value);
+        end = stress_clock::now() - (copy_end - copy_start);
+        return true;
+    }
+
+    /** \brief Estrae l'elemento in testa
+     * @return false se il buffer è vuoto
+     */
+    bool pop(T &value) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (cb.size() == 0)
+            return false;
+        const cbuffer<T, concurrent_read> &view = cb;
+        value = view[0];
+        cb.pop();
+        return true;
+    }
+};
+
+/** \brief Funtore che copia la finestra letta con try_visit() in un array */
+template <class T>
+struct window_collector {
+    T *dest;
+    unsigned int *count;
+
+    window_collector(T *d, unsigned int *c) : dest(d), count(c) {}
+
+    void operator()(const T &value) {
+        dest[(*count)++] = value;
+    }
+};
+
+/** \brief Verifica che una finestra letta sia consistente
+ * Ogni elemento deve essere integro e, per ogni produttore, i seq devono essere
+ * strettamente crescenti dal più vecchio al più recente.
+ */
+template <class IT>
+bool consistent_window(IT begin, IT end, std::vector<long long> &last) {
+    for (unsigned int i = 0; i < last.size(); i++)
+        last[i] = -1;
+    for (; begin != end; ++begin) {
+        if (begin->producer >= last.size() || !begin->intact())
+            return false;
+        if (static_cast<long long>(begin->seq) <= last[begin->producer])
+            return false;
+        last[begin->producer] = static_cast<long long>(begin->seq);
+    }
+    return true;
+}
+
+/** \brief Legge la finestra copiando il buffer sotto il mutex
+ * @return numero di elementi letti in window
+ */
+template <class T>
+unsigned int read_window(locked_cbuffer<T, false> &buffer, std::vector<T> &window, stress_result &) {
+    std::unique_lock<std::mutex> guard(buffer.lock);
+    cbuffer<T> copy(buffer.cb);
+    guard.unlock();
+    unsigned int n = 0;
+    typename cbuffer<T>::const_iterator it = copy.begin(), ie = copy.end();
+    for (; it != ie; ++it)
+        window[n++] = *it;
+    return n;
+}
+
+/** \brief Legge la finestra con try_visit(), senza mutex
+ * @return numero di elementi letti in window
+ */
+template <class T>
+unsigned int read_window(locked_cbuffer<T, true> &buffer, std::vector<T> &window, stress_result &r) {
+    unsigned int n = 0;
+    while (!buffer.cb.try_visit(window_collector<T>(&window[0], &n))) {
+        r.read_retries++;
+        n = 0;
+    }
+    return n;
+}
+
+/** \brief Registra un elemento consumato, sovrascritto o rimasto nel buffer
+ * Controlla integrità, ordine per produttore rispetto a last e unicità in seen.
+ */
+template <class T>
+void observe(const T &e, std::vector<long long> &last, std::vector<seen_set> &seen, stress_result &r) {
+    if (e.producer >= last.size() || !e.intact()) {
+        r.corrupted++;
+        return;
+    }
+    if (static_cast<long long>(e.seq) <= last[e.producer])
+        r.order_violations++;
+    last[e.producer] = static_cast<long long>(e.seq);
+    if (!seen[e.producer].mark(e.seq))
+        r.duplicates++;
+}
+
+/** \brief Esegue la prova con elementi di N byte
+ * Produttori e consumatori girano per cfg.duration secondi; alla fine il
+ * contenuto residuo del buffer viene svuotato e i risultati dei thread uniti.
+ */
+template <unsigned int N, bool concurrent_read>
+stress_result run_stress(const stress_config &cfg) {
+    typedef payload<N> element;
+
+    locked_cbuffer<element, concurrent_read> buffer(cfg.capacity);
+    std::atomic<bool> stop(false);
+    std::vector<stress_result> partial(cfg.producers + cfg.consumers + cfg.readers);
+    std::vector<seen_set> seen(cfg.producers);
+    std::vector<std::thread> threads;
+
+    for (unsigned int p = 0; p < cfg.producers; p++) {
+        threads.push_back(std::thread([&, p]() {
+            stress_result &r = partial[p];
+            // Gli elementi sovrascritti sono sempre la testa del buffer, quindi
+            // anche questi devono avere seq crescenti per produttore
+            std::vector<long long> last(cfg.producers, -1);
+            element dropped;
+            stress_clock::time_point end;
+            // Con --rate ogni produttore inserisce al più cfg.rate elementi al secondo
+            stress_clock::time_point next = stress_clock::now();
+            stress_clock::duration period = std::chrono::duration_cast<stress_clock::duration>(
+                std::chrono::duration<double>(cfg.rate > 0 ? 1.0 / cfg.rate : 0.0));
+            for (unsigned long long seq = 0; !stop.load(std::memory_order_relaxed); seq++) {
+                if (cfg.rate > 0) {
+                    std::this_thread::sleep_until(next);
+                    next += period;
+                }
+                element e(p, seq);
+                stress_clock::time_point start = stress_clock::now();
+                bool overwritten = buffer.push(e, dropped, end);
+                r.push_latency.record(elapsed_ns(start, end));
+                r.produced++;
+                if (overwritten) {
+                    r.overwritten++;
+                    observe(dropped, last, seen, r);
+                }
+            }
+        }));
+    }
+
+    for (unsigned int c = 0; c < cfg.consumers; c++) {
+        threads.push_back(std::thread([&, c]() {
+            stress_result &r = partial[cfg.producers + c];
+            // Ultimo seq visto per ogni produttore: il buffer è FIFO, quindi
+            // ogni consumatore deve vedere seq strettamente crescenti
+            std::vector<long long> last(cfg.producers, -1);
+            element e;
+            while (!stop.load(std::memory_order_relaxed)) {
+                stress_clock::time_point start = stress_clock::now();
+                bool got = buffer.pop(e);
+                stress_clock::time_point end = stress_clock::now();
+                if (!got) {
+                    r.empty_polls++;
+                    continue;
+                }
+                r.pop_latency.record(elapsed_ns(start, end));
+                r.consumed++;
+                observe(e, last, seen, r);
+            }
+        }));
+    }
+
+    for (unsigned int rd = 0; rd < cfg.readers; rd++) {
+        threads.push_back(std::thread([&, rd]() {
+            stress_result &r = partial[cfg.producers + cfg.consumers + rd];
+            std::vector<element> window(cfg.capacity);
+            std::vector<long long> last(cfg.producers);
+            while (!stop.load(std::memory_order_relaxed)) {
+                stress_clock::time_point start = stress_clock::now();
+                unsigned int n = read_window(buffer, window, r);
+                r.read_latency.record(elapsed_ns(start, stress_clock::now()));
+                bool consistent = consistent_window(window.begin(), window.begin() + n, last);
+                if (!consistent)
+                    r.torn_reads++;
+            }
+        }));
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(cfg.duration));
+    stop.store(true);
+    for (unsigned int i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    stress_result total;
+    // Svuoto il buffer: anche gli elementi rimasti vanno osservati una volta sola
+    std::vector<long long> last(cfg.producers, -1);
+    element e;
+    while (buffer.pop(e)) {
+        total.remaining++;
+        observe(e, last, seen, total);
+    }
+    for (unsigned int i = 0; i < partial.size(); i++) {
+        total.push_latency.merge(partial[i].push_latency);
+        total.pop_latency.merge(partial[i].pop_latency);
+        total.read_latency.merge(partial[i].read_latency);
+        total.produced += partial[i].produced;
+        total.consumed += partial[i].consumed;
+        total.overwritten += partial[i].overwritten;
+        total.empty_polls += partial[i].empty_polls;
+        total.duplicates += partial[i].duplicates;
+        total.order_violations += partial[i].order_violations;
+        total.corrupted += partial[i].corrupted;
+        total.read_retries += partial[i].read_retries;
+        total.torn_reads += partial[i].torn_reads;
+    }
+    for (unsigned int p = 0; p < cfg.producers; p++)
+        total.lost += seen[p].missing(partial[p].produced);
+    return total;
+}
+
+/** \brief Sceglie la dimensione dell'elemento tra quelle istanziate
+ * Il buffer con letture concorrenti si usa solo in modalità snapshot: altrimenti
+ * si misura il cbuffer di default.
+ */
+template <bool concurrent_read>
+stress_result dispatch_size(const stress_config &cfg) {
+    switch (cfg.elem_size) {
+        case 16: return run_stress<16, concurrent_read>(cfg);
+        case 64: return run_stress<64, concurrent_read>(cfg);
+        case 256: return run_stress<256, concurrent_read>(cfg);
+        case 1024: return run_stress<1024, concurrent_read>(cfg);
+        case 4096: return run_stress<4096, concurrent_read>(cfg);
+    }
+    std::cerr << "elem-size non supportata: " << cfg.elem_size
+              << " (valori ammessi: 16, 64, 256, 1024, 4096)" << std::endl;
+    std::exit(2);
+}
+
+stress_result dispatch(const stress_config &cfg) {
+    if (cfg.readers > 0 && cfg.read_mode == "snapshot")
+        return dispatch_size<true>(cfg);
+    return dispatch_size<false>(cfg);
+}
+
+void write_csv(std::ostream &os, const stress_config &cfg, const stress_result &r) {
+    os << "op,producers,consumers,readers,read_mode,capacity,elem_size,duration_s,rate,count,p50_ns,p99_ns,p999_ns,max_ns,"
+          "produced,consumed,overwritten,remaining,empty_polls,duplicates,lost,order_violations,corrupted,read_retries,torn_reads,passed" << std::endl;
+    const char *names[3] = {"push", "pop", "read"};
+    const latency_histogram *h[3] = {&r.push_latency, &r.pop_latency, &r.read_latency};
+    for (unsigned int i = 0; i < 3; i++) {
+        os << names[i] << ',' << cfg.producers << ',' << cfg.consumers << ','
+           << cfg.readers << ',' << cfg.read_mode << ',' << cfg.capacity << ',' << cfg.elem_size << ',' << cfg.duration << ','
+           << cfg.rate << ','
+           << h[i]->count() << ',' << h[i]->percentile(50) << ','
+           << h[i]->percentile(99) << ',' << h[i]->percentile(99.9) << ','
+           << h[i]->max() << ',' << r.produced << ',' << r.consumed << ','
+           << r.overwritten << ',' << r.remaining << ',' << r.empty_polls << ','
+           << r.duplicates << ',' << r.lost << ',' << r.order_violations << ','
+           << r.corrupted << ',' << r.read_retries << ',' << r.torn_reads << ','
+           << (r.passed() ? "true" : "false") << std::endl;
+    }
+}
+
+void write_json_histogram(std::ostream &os, const char *name, const latency_histogram &h) {
+    os << "    \"" << name << "\": {\"count\": " << h.count()
+       << ", \"p50_ns\": " << h.percentile(50)
+       << ", \"p99_ns\": " << h.percentile(99)
+       << ", \"p999_ns\": " << h.percentile(99.9)
+       << ", \"max_ns\": " << h.max() << "}";
+}
+
+void write_json(std::ostream &os, const stress_config &cfg, const stress_result &r) {
+    os << "{" << std::endl
+       << "  \"config\": {\"producers\": " << cfg.producers
+       << ", \"consumers\": " << cfg.consumers
+       << ", \"readers\": " << cfg.readers
+       << ", \"read_mode\": \"" << cfg.read_mode << "\""
+       << ", \"capacity\": " << cfg.capacity
+       << ", \"elem_size\": " << cfg.elem_size
+       << ", \"duration_s\": " << cfg.duration
+       << ", \"rate\": " << cfg.rate << "}," << std::endl
+       << "  \"latency\": {" << std::endl;
+    write_json_histogram(os, "push", r.push_latency);
+    os << "," << std::endl;
+    write_json_histogram(os, "pop", r.pop_latency);
+    os << "," << std::endl;
+    write_json_histogram(os, "read", r.read_latency);
+    os << std::endl << "  }," << std::endl
+       << "  \"invariants\": {\"produced\": " << r.produced
+       << ", \"consumed\": " << r.consumed
+       << ", \"overwritten\": " << r.overwritten
+       << ", \"remaining\": " << r.remaining
+       << ", \"empty_polls\": " << r.empty_polls
+       << ", \"duplicates\": " << r.duplicates
+       << ", \"lost\": " << r.lost
+       << ", \"order_violations\": " << r.order_violations
+       << ", \"corrupted\": " << r.corrupted
+       << ", \"read_retries\": " << r.read_retries
+       << ", \"torn_reads\": " << r.torn_reads
+       << ", \"no_loss\": " << (r.no_loss() ? "true" : "false") << "}," << std::endl
+       << "  \"passed\": " << (r.passed() ? "true" : "false") << std::endl
+       << "}" << std::endl;
+}
+
+void usage(const char *name) {
+    std::cerr << "Uso: " << name << " [opzioni]" << std::endl
+              << "  --producers N    thread produttori (default 2)" << std::endl
+              << "  --consumers N    thread consumatori (default 2)" << std::endl
+              << "  --readers N      thread lettori della finestra corrente (default 0)" << std::endl
+              << "  --read-mode M    snapshot (try_visit senza lock) o copy (copia sotto mutex)" << std::endl
+              << "  --capacity N     capacità del buffer (default 1024)" << std::endl
+              << "  --elem-size N    byte per elemento: 16, 64, 256, 1024, 4096 (default 64)" << std::endl
+              << "  --duration S     durata in secondi (default 5)" << std::endl
+              << "  --rate R         inserimenti al secondo per produttore (default 0 = senza limite;" << std::endl
+              << "                   senza limite i produttori tengono il buffer pieno e la prova" << std::endl
+              << "                   misura soprattutto sovrascritture, con pochi pop)" << std::endl
+              << "  --format F       csv o json (default csv)" << std::endl
+              << "  --out FILE       file di output (default stdout)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    stress_config cfg;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--help" || arg == "-h") {
+            usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *value = argv[++i];
+        if (arg == "--producers")
+            cfg.producers = std::strtoul(value, NULL, 10);
+        else if (arg == "--consumers")
+            cfg.consumers = std::strtoul(value, NULL, 10);
+        else if (arg == "--readers")
+            cfg.readers = std::strtoul(value, NULL, 10);
+        else if (arg == "--read-mode")
+            cfg.read_mode = value;
+        else if (arg == "--capacity")
+            cfg.capacity = std::strtoul(value, NULL, 10);
+        else if (arg == "--elem-size")
+            cfg.elem_size = std::strtoul(value, NULL, 10);
+        else if (arg == "--duration")
+            cfg.duration = std::strtod(value, NULL);
+        else if (arg == "--rate")
+            cfg.rate = std::strtod(value, NULL);
+        else if (arg == "--format")
+            cfg.format = value;
+        else if (arg == "--out")
+            cfg.out = value;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (cfg.capacity == 0 || cfg.rate < 0 || (cfg.format != "csv" && cfg.format != "json") ||
+        (cfg.read_mode != "snapshot" && cfg.read_mode != "copy")) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    stress_result result = dispatch(cfg);
+
+    std::ofstream file;
+    if (!cfg.out.empty()) {
+        file.open(cfg.out.c_str());
+        if (!file) {
+            std::cerr << "Impossibile scrivere " << cfg.out << std::endl;
+            return 2;
+        }
+    }
+    std::ostream &os = cfg.out.empty() ? std::cout : file;
+    if (cfg.format == "json")
+        write_json(os, cfg, result);
+    else
+        write_csv(os, cfg, result);
+
+    if (!result.passed()) {
+        std::cerr << "Invarianti violate" << std::endl;
+        return 1;
+    }
+    return 0;
+}